@@ -9,10 +9,19 @@ sources = [
 	'class.cpp',
 	'comparison_operators.cpp',
 	'default_new.cpp',
+	'hash.cpp',
+	'hashed_value_ptr.cpp',
 	'make_value.cpp',
+	'persistent_vector.cpp',
+	'shareable.cpp',
 	'value_ptr.cpp',
 ]
 
 source_directory = 'value_ptr'
 
-programs = [Program('test', sources)]
+programs = [
+	Program('test', sources),
+	Program('hashed_value_ptr_benchmark', ['hashed_value_ptr_benchmark.cpp']),
+	Program('persistent_vector_benchmark', ['persistent_vector_benchmark.cpp']),
+	Program('shareable_benchmark', ['shareable_benchmark.cpp']),
+]
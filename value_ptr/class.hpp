@@ -20,6 +20,16 @@ namespace detail {
 // std::unique_ptr is implemented via a two-element std::tuple in gcc.
 class empty_class {
 };
+
+// Converts the owned pointer of a value_ptr to a std::shared_ptr. This can be
+// specialized for deleters that know a better way to share their pointer.
+template<typename T, typename Deleter>
+class shared_ptr_conversion {
+public:
+	static std::shared_ptr<T> convert(std::unique_ptr<T, Deleter> && ptr) {
+		return std::shared_ptr<T>(std::move(ptr));
+	}
+};
 }	// namespace detail
 
 template<typename T, typename Cloner = default_new<T>, typename Deleter = std::default_delete<T>>
@@ -165,11 +175,21 @@ public:
 		return get_unique_ptr()[index];
 	}
 
+	// Gives up ownership to a std::shared_ptr, like moving a std::unique_ptr
+	// into a std::shared_ptr. The cloner is discarded.
+	std::shared_ptr<T> share() && {
+		return detail::shared_ptr_conversion<T, Deleter>::convert(std::move(get_unique_ptr()));
+	}
+	template<typename U, SMART_POINTER_REQUIRES(std::is_convertible<std::shared_ptr<T>, std::shared_ptr<U>>::value)>
+	operator std::shared_ptr<U>() && {
+		return std::move(*this).share();
+	}
+
 private:
 	enum class copy_construct {};
 	template<typename U, typename C, typename D>
 	value_ptr(copy_construct, value_ptr<U, C, D> const & other):
-		value_ptr(other != nullptr ? clone(*other) : nullptr, other.get_cloner(), other.get_deleter()) {
+		value_ptr(other != nullptr ? other.clone(*other) : nullptr, other.get_cloner(), other.get_deleter()) {
 		static_assert(noexcept(other.get_cloner()) and noexcept(other.get_deleter()), "Must be noexcept.");
 	}
 	
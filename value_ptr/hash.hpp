@@ -0,0 +1,70 @@
+// Copyright David Stone 2015.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// std::hash for value_ptr hashes the pointer, to be consistent with the
+// comparison operators. value_hash and value_equal are adapters for keying
+// unordered containers by the pointed-to value instead.
+
+#pragma once
+
+#include "class.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+namespace smart_pointer {
+
+template<typename T, typename Hash = std::hash<T>>
+class value_hash {
+public:
+	constexpr value_hash() = default;
+	constexpr explicit value_hash(Hash hash):
+		hasher(std::move(hash)) {
+	}
+	// A null value_ptr has no value, so all null pointers hash the same.
+	template<typename C, typename D>
+	std::size_t operator()(value_ptr<T, C, D> const & ptr) const noexcept(noexcept(std::declval<Hash const &>()(std::declval<T const &>()))) {
+		return ptr ? hasher(*ptr) : 0;
+	}
+private:
+	Hash hasher;
+};
+
+template<typename T, typename KeyEqual = std::equal_to<T>>
+class value_equal {
+public:
+	constexpr value_equal() = default;
+	constexpr explicit value_equal(KeyEqual equal):
+		key_equal(std::move(equal)) {
+	}
+	// Two null pointers are equal. A null pointer is not equal to any value.
+	// Identical pointers are assumed to be equal without comparing the values.
+	template<typename C1, typename D1, typename C2, typename D2>
+	bool operator()(value_ptr<T, C1, D1> const & lhs, value_ptr<T, C2, D2> const & rhs) const {
+		if (lhs.get() == rhs.get()) {
+			return true;
+		}
+		if (!lhs or !rhs) {
+			return false;
+		}
+		return key_equal(*lhs, *rhs);
+	}
+private:
+	KeyEqual key_equal;
+};
+
+}	// namespace smart_pointer
+
+namespace std {
+
+template<typename T, typename C, typename D>
+struct hash<smart_pointer::value_ptr<T, C, D>> {
+	std::size_t operator()(smart_pointer::value_ptr<T, C, D> const & ptr) const noexcept {
+		return std::hash<typename smart_pointer::value_ptr<T, C, D>::pointer>()(ptr.get());
+	}
+};
+
+}	// namespace std
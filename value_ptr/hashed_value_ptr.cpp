@@ -0,0 +1,6 @@
+// Copyright David Stone 2015.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+#include "hashed_value_ptr.hpp"
@@ -0,0 +1,212 @@
+// Copyright David Stone 2015.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// hashed_value_ptr is a value_ptr intended to be used as the key of an
+// unordered container. Unlike value_ptr, it compares and hashes by value, and
+// it stores the hash of the pointed-to object next to the pointer so that
+// lookups and rehashes do not need to hash the whole object again.
+//
+// The hash is computed whenever the pointed-to object changes, never in a
+// const member function, so const hashed_value_ptr objects can be used from
+// several threads at once. To keep the hash correct, the pointed-to object is
+// only reachable through a const reference, except inside mutate().
+
+#pragma once
+
+#include "class.hpp"
+#include "requires.hpp"
+
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace smart_pointer {
+
+template<typename T, typename Cloner = default_new<T>, typename Deleter = std::default_delete<T>, typename Hash = std::hash<T>>
+class hashed_value_ptr {
+private:
+	static_assert(!std::is_array<T>::value, "hashed_value_ptr cannot be used with array types.");
+	using value_ptr_type = value_ptr<T, Cloner, Deleter>;
+	using base_type = std::tuple<value_ptr_type, Hash, detail::empty_class>;
+public:
+	using cloner_type = typename value_ptr_type::cloner_type;
+	using deleter_type = typename value_ptr_type::deleter_type;
+	using hasher = Hash;
+	using pointer = typename value_ptr_type::pointer;
+	using element_type = typename value_ptr_type::element_type;
+
+	constexpr hashed_value_ptr(std::nullptr_t = nullptr) noexcept:
+		base(value_ptr_type(nullptr), hasher{}, detail::empty_class()),
+		cached_hash(0) {
+	}
+	explicit hashed_value_ptr(value_ptr_type && ptr, hasher hash = hasher{}):
+		base(std::move(ptr), std::move(hash), detail::empty_class()),
+		cached_hash(compute_hash()) {
+	}
+	template<typename U, SMART_POINTER_REQUIRES(std::is_convertible<U, element_type>::value)>
+	hashed_value_ptr(U && other):
+		hashed_value_ptr(value_ptr_type(std::forward<U>(other))) {
+	}
+
+	// The copy has an equal value, so it also has an equal hash.
+	hashed_value_ptr(hashed_value_ptr const & other):
+		base(other.base),
+		cached_hash(other.cached_hash) {
+	}
+	hashed_value_ptr(hashed_value_ptr && other) noexcept:
+		base(std::move(other.base)),
+		cached_hash(std::exchange(other.cached_hash, 0)) {
+	}
+
+	hashed_value_ptr & operator=(hashed_value_ptr const & other) {
+		return *this = hashed_value_ptr(other);
+	}
+	hashed_value_ptr & operator=(hashed_value_ptr && other) noexcept {
+		base = std::move(other.base);
+		cached_hash = std::exchange(other.cached_hash, 0);
+		return *this;
+	}
+	hashed_value_ptr & operator=(std::nullptr_t) noexcept {
+		reset();
+		return *this;
+	}
+
+	pointer release() noexcept {
+		cached_hash = 0;
+		return get_value_ptr().release();
+	}
+	void reset(pointer ptr = pointer()) noexcept(is_nothrow_hashable) {
+		get_value_ptr().reset(ptr);
+		cached_hash = compute_hash();
+	}
+
+	element_type const * get() const noexcept {
+		return get_value_ptr().get();
+	}
+	deleter_type const & get_deleter() const noexcept {
+		return get_value_ptr().get_deleter();
+	}
+	cloner_type const & get_cloner() const noexcept {
+		return get_value_ptr().get_cloner();
+	}
+	hasher const & hash_function() const noexcept {
+		return std::get<1>(base);
+	}
+	explicit operator bool() const noexcept {
+		return static_cast<bool>(get_value_ptr());
+	}
+
+	element_type const & operator*() const {
+		return *get();
+	}
+	element_type const * operator->() const noexcept {
+		return get();
+	}
+
+	// The only way to modify the pointed-to object. Calls function with a
+	// mutable reference to the object, which must not be null, and then
+	// recomputes the hash, even if function throws.
+	template<typename Function>
+	void mutate(Function && function) {
+		try {
+			std::forward<Function>(function)(*get_value_ptr());
+		} catch (...) {
+			cached_hash = compute_hash();
+			throw;
+		}
+		cached_hash = compute_hash();
+	}
+
+	// A null hashed_value_ptr hashes to 0, like value_hash.
+	std::size_t hash() const noexcept {
+		return cached_hash;
+	}
+
+private:
+	static constexpr bool is_nothrow_hashable = noexcept(std::declval<hasher const &>()(std::declval<element_type const &>()));
+
+	std::size_t compute_hash() const noexcept(is_nothrow_hashable) {
+		return *this ? hash_function()(**this) : 0;
+	}
+
+	value_ptr_type const & get_value_ptr() const noexcept {
+		return std::get<0>(base);
+	}
+	value_ptr_type & get_value_ptr() noexcept {
+		return std::get<0>(base);
+	}
+	base_type base;
+	std::size_t cached_hash;
+};
+
+namespace detail {
+
+// Cached hashes can only be compared if they were computed by the same hash
+// function. Every object of a stateless hasher type computes the same one.
+template<typename H1, typename H2>
+constexpr bool is_same_hash_function() {
+	return std::is_same<H1, H2>::value and std::is_empty<H1>::value;
+}
+
+}	// namespace detail
+
+// Unlike value_ptr, hashed_value_ptr compares by value. Two null pointers are
+// equal, and a null pointer is not equal to any value. If both hashes come
+// from the same stateless hash function, unequal hashes answer the comparison
+// without looking at the values.
+template<typename T, typename C1, typename D1, typename H1, typename C2, typename D2, typename H2>
+bool operator==(hashed_value_ptr<T, C1, D1, H1> const & lhs, hashed_value_ptr<T, C2, D2, H2> const & rhs) {
+	if (lhs.get() == rhs.get()) {
+		return true;
+	}
+	if (!lhs or !rhs) {
+		return false;
+	}
+	if (detail::is_same_hash_function<H1, H2>() and lhs.hash() != rhs.hash()) {
+		return false;
+	}
+	return *lhs == *rhs;
+}
+
+template<typename T, typename C1, typename D1, typename H1, typename C2, typename D2, typename H2>
+bool operator!=(hashed_value_ptr<T, C1, D1, H1> const & lhs, hashed_value_ptr<T, C2, D2, H2> const & rhs) {
+	return !(lhs == rhs);
+}
+
+
+template<typename T, typename C, typename D, typename H>
+bool operator==(hashed_value_ptr<T, C, D, H> const & ptr, std::nullptr_t) noexcept {
+	return !ptr;
+}
+template<typename T, typename C, typename D, typename H>
+bool operator==(std::nullptr_t, hashed_value_ptr<T, C, D, H> const & ptr) noexcept {
+	return !ptr;
+}
+
+template<typename T, typename C, typename D, typename H>
+bool operator!=(hashed_value_ptr<T, C, D, H> const & ptr, std::nullptr_t) noexcept {
+	return static_cast<bool>(ptr);
+}
+template<typename T, typename C, typename D, typename H>
+bool operator!=(std::nullptr_t, hashed_value_ptr<T, C, D, H> const & ptr) noexcept {
+	return static_cast<bool>(ptr);
+}
+
+}	// namespace smart_pointer
+
+namespace std {
+
+template<typename T, typename C, typename D, typename H>
+struct hash<smart_pointer::hashed_value_ptr<T, C, D, H>> {
+	// Being noexcept lets unordered containers use the stored hash instead of
+	// storing another copy of it in every node.
+	std::size_t operator()(smart_pointer::hashed_value_ptr<T, C, D, H> const & ptr) const noexcept {
+		return ptr.hash();
+	}
+};
+
+}	// namespace std
@@ -0,0 +1,92 @@
+// Copyright David Stone 2015.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Compares keying an unordered_set by value with value_hash / value_equal,
+// which hash the whole object every time, against hashed_value_ptr, which
+// hashes each object once.
+//
+// Both hashers are noexcept, so std::unordered_set does not store the hash in
+// its nodes, and a rehash has to call the hasher for every element. Lookups
+// are timed both with the keys that were inserted, and with keys that are
+// built inside the timed loop, which includes computing the hash that
+// hashed_value_ptr stores.
+
+#include "value_ptr.hpp"
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace smart_pointer;
+namespace {
+
+constexpr std::size_t key_count = 100000;
+constexpr std::size_t key_length = 256;
+constexpr std::size_t lookup_rounds = 10;
+constexpr std::size_t rehash_rounds = 5;
+
+std::string make_key(std::size_t const n) {
+	auto key = std::string(key_length, 'k');
+	key += std::to_string(n);
+	return key;
+}
+
+template<typename Key>
+std::vector<Key> make_keys() {
+	std::vector<Key> keys;
+	keys.reserve(key_count);
+	for (std::size_t n = 0; n != key_count; ++n) {
+		keys.emplace_back(make_key(n));
+	}
+	return keys;
+}
+
+template<typename Function>
+double time_in_ms(Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+template<typename Set, typename Key>
+void benchmark(char const * name) {
+	auto const keys = make_keys<Key>();
+	Set set;
+	for (auto const & key : keys) {
+		set.insert(key);
+	}
+	std::size_t found = 0;
+	auto const lookup = time_in_ms([&]() {
+		for (std::size_t round = 0; round != lookup_rounds; ++round) {
+			for (auto const & key : keys) {
+				found += set.count(key);
+			}
+		}
+	});
+	auto const fresh_lookup = time_in_ms([&]() {
+		for (std::size_t round = 0; round != lookup_rounds; ++round) {
+			for (std::size_t n = 0; n != key_count; ++n) {
+				Key const key(make_key(n));
+				found += set.count(key);
+			}
+		}
+	});
+	auto const rehash = time_in_ms([&]() {
+		for (std::size_t round = 0; round != rehash_rounds; ++round) {
+			set.rehash(set.bucket_count() * 2);
+		}
+	});
+	std::cout << name << ": lookup " << lookup << " ms, lookup with new keys " << fresh_lookup << " ms, rehash " << rehash << " ms (found " << found << ")\n";
+}
+
+}	// namespace
+
+int main() {
+	benchmark<std::unordered_set<value_ptr<std::string>, value_hash<std::string>, value_equal<std::string>>, value_ptr<std::string>>("value_hash");
+	benchmark<std::unordered_set<hashed_value_ptr<std::string>>, hashed_value_ptr<std::string>>("hashed_value_ptr");
+}
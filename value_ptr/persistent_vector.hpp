@@ -0,0 +1,266 @@
+// Copyright David Stone 2015.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// persistent_vector is a sequence of value_ptr<T, Cloner, Deleter> with value
+// semantics, in which copies share structure. It is a tree with a branching
+// factor of 32 in which every node and every element is reference counted.
+// Copying a persistent_vector only copies the pointer to the root, and a
+// modification only copies the nodes on the path to the modified element that
+// are shared with another copy. Elements are only cloned when they are
+// modified with update() while shared.
+//
+// Elements are never modified in place while shared, so they are only
+// accessible through a const reference, except through update(). The
+// elements are handed to std::shared_ptr with value_ptr::share(), so elements
+// allocated by shareable_new do not need to allocate a control block.
+//
+// Like a value_ptr, every element keeps its own cloner and deleter, which are
+// stored next to it and used to clone it. The cloner of the vector is only
+// used for elements that are created from a value of the element type.
+//
+// Thread safety is the same as for std::shared_ptr: different
+// persistent_vector objects can be read and modified from different threads
+// even if they share structure, but one persistent_vector object that is
+// modified must not be used from another thread at the same time.
+
+#pragma once
+
+#include "class.hpp"
+#include "requires.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace smart_pointer {
+namespace detail {
+
+constexpr std::size_t persistent_bits = 5;
+constexpr std::size_t persistent_width = std::size_t(1) << persistent_bits;
+constexpr std::size_t persistent_mask = persistent_width - 1;
+
+// The type of a node is known from its depth, so it is not polymorphic.
+class persistent_node {
+};
+
+class persistent_branch : public persistent_node {
+public:
+	std::array<std::shared_ptr<persistent_node>, persistent_width> children;
+};
+
+template<typename T, typename Cloner, typename Deleter>
+class persistent_leaf : public persistent_node {
+public:
+	std::array<std::tuple<std::shared_ptr<T>, Cloner, Deleter>, persistent_width> elements;
+};
+
+}	// namespace detail
+
+template<typename T, typename Cloner = default_new<T>, typename Deleter = std::default_delete<T>>
+class persistent_vector {
+private:
+	static_assert(!std::is_array<T>::value, "persistent_vector cannot be used with array types.");
+	using node_pointer = std::shared_ptr<detail::persistent_node>;
+	using branch = detail::persistent_branch;
+	using leaf = detail::persistent_leaf<T, Cloner, Deleter>;
+	using base_type = std::tuple<node_pointer, Cloner, detail::empty_class>;
+public:
+	using value_ptr_type = value_ptr<T, Cloner, Deleter>;
+	using cloner_type = typename value_ptr_type::cloner_type;
+	using deleter_type = typename value_ptr_type::deleter_type;
+	using element_type = typename value_ptr_type::element_type;
+	using size_type = std::size_t;
+
+	persistent_vector() = default;
+	explicit persistent_vector(cloner_type cloner):
+		base(node_pointer(), std::move(cloner), detail::empty_class()) {
+	}
+	explicit persistent_vector(std::vector<value_ptr_type> values, cloner_type cloner = cloner_type{}):
+		persistent_vector(std::move(cloner)) {
+		for (auto & value : values) {
+			push_back(std::move(value));
+		}
+	}
+
+	// A copy shares every node and element, so it is O(1).
+	persistent_vector(persistent_vector const & other) = default;
+	persistent_vector(persistent_vector && other) noexcept:
+		base(std::move(other.base)),
+		count(std::exchange(other.count, 0)),
+		shift(std::exchange(other.shift, 0)) {
+	}
+	persistent_vector & operator=(persistent_vector const & other) = default;
+	persistent_vector & operator=(persistent_vector && other) noexcept {
+		base = std::move(other.base);
+		count = std::exchange(other.count, 0);
+		shift = std::exchange(other.shift, 0);
+		return *this;
+	}
+
+	size_type size() const noexcept {
+		return count;
+	}
+	bool empty() const noexcept {
+		return count == 0;
+	}
+	cloner_type const & get_cloner() const noexcept {
+		return std::get<1>(base);
+	}
+
+	element_type const * get(size_type const index) const noexcept {
+		return std::get<0>(find_element(index)).get();
+	}
+	element_type const & operator[](size_type const index) const {
+		return *get(index);
+	}
+	// Returns a deep copy of the element, which is not shared with anything.
+	value_ptr_type copy(size_type const index) const {
+		auto const & element = find_element(index);
+		return clone_element(element);
+	}
+
+	void push_back(value_ptr_type value) {
+		auto element = make_element(std::move(value));
+		if (count == (detail::persistent_width << shift)) {
+			auto new_root = std::make_shared<branch>();
+			new_root->children[0] = std::move(get_root());
+			get_root() = std::move(new_root);
+			shift += detail::persistent_bits;
+		}
+		mutable_element(count) = std::move(element);
+		++count;
+	}
+	template<typename U, SMART_POINTER_REQUIRES(std::is_convertible<U, element_type>::value)>
+	void push_back(U && value) {
+		push_back(value_ptr_type(clone(std::forward<U>(value)), get_cloner(), deleter_type{}));
+	}
+
+	void pop_back() {
+		--count;
+		if (count == 0) {
+			get_root().reset();
+			shift = 0;
+			return;
+		}
+		erase_last(get_root(), shift, count);
+		while (shift != 0 and !root_branch().children[1]) {
+			get_root() = root_branch().children[0];
+			shift -= detail::persistent_bits;
+		}
+	}
+
+	void set(size_type const index, value_ptr_type value) {
+		auto element = make_element(std::move(value));
+		mutable_element(index) = std::move(element);
+	}
+	template<typename U, SMART_POINTER_REQUIRES(std::is_convertible<U, element_type>::value)>
+	void set(size_type const index, U && value) {
+		set(index, value_ptr_type(clone(std::forward<U>(value)), get_cloner(), deleter_type{}));
+	}
+
+	// Calls function with a mutable reference to the element, which must not
+	// be null. The element is cloned with its own cloner and deleter first if
+	// it is shared with another copy.
+	template<typename Function>
+	void update(size_type const index, Function && function) {
+		auto & element = mutable_element(index);
+		if (!is_unique(std::get<0>(element))) {
+			element = make_element(clone_element(element));
+		}
+		std::forward<Function>(function)(*std::get<0>(element));
+	}
+
+private:
+	using element_storage = std::tuple<std::shared_ptr<T>, Cloner, Deleter>;
+
+	static element_storage make_element(value_ptr_type && value) {
+		auto cloner = value.get_cloner();
+		auto deleter = value.get_deleter();
+		return element_storage(std::move(value).share(), std::move(cloner), std::move(deleter));
+	}
+	static value_ptr_type clone_element(element_storage const & element) {
+		auto const & ptr = std::get<0>(element);
+		auto const & cloner = std::get<1>(element);
+		return value_ptr_type(ptr != nullptr ? cloner(static_cast<element_type const &>(*ptr)) : nullptr, cloner, std::get<2>(element));
+	}
+
+	// use_count() is a relaxed load. If another thread just released the last
+	// other copy, its reads of the object must happen before our writes.
+	template<typename Pointer>
+	static bool is_unique(std::shared_ptr<Pointer> const & ptr) noexcept {
+		if (ptr.use_count() != 1) {
+			return false;
+		}
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return true;
+	}
+
+	// Returns a node that this vector can modify, copying it if it is shared.
+	template<typename Node>
+	static Node & unshare(node_pointer & node) {
+		if (!node) {
+			node = std::make_shared<Node>();
+		} else if (!is_unique(node)) {
+			node = std::make_shared<Node>(static_cast<Node const &>(*node));
+		}
+		return static_cast<Node &>(*node);
+	}
+
+	leaf const & find_leaf(size_type const index) const noexcept {
+		auto node = get_root().get();
+		for (auto node_shift = shift; node_shift != 0; node_shift -= detail::persistent_bits) {
+			node = static_cast<branch const &>(*node).children[(index >> node_shift) & detail::persistent_mask].get();
+		}
+		return static_cast<leaf const &>(*node);
+	}
+	element_storage const & find_element(size_type const index) const noexcept {
+		return find_leaf(index).elements[index & detail::persistent_mask];
+	}
+	element_storage & mutable_element(size_type const index) {
+		auto node = &get_root();
+		for (auto node_shift = shift; node_shift != 0; node_shift -= detail::persistent_bits) {
+			node = &unshare<branch>(*node).children[(index >> node_shift) & detail::persistent_mask];
+		}
+		return unshare<leaf>(*node).elements[index & detail::persistent_mask];
+	}
+
+	// Returns whether the node no longer holds any elements.
+	static bool erase_last(node_pointer & node, size_type const node_shift, size_type const index) {
+		if (node_shift == 0) {
+			std::get<0>(unshare<leaf>(node).elements[index & detail::persistent_mask]).reset();
+			return (index & detail::persistent_mask) == 0;
+		}
+		auto const position = (index >> node_shift) & detail::persistent_mask;
+		auto & child = unshare<branch>(node).children[position];
+		if (erase_last(child, node_shift - detail::persistent_bits, index)) {
+			child.reset();
+		}
+		return position == 0 and !child;
+	}
+
+	branch const & root_branch() const noexcept {
+		return static_cast<branch const &>(*get_root());
+	}
+	node_pointer const & get_root() const noexcept {
+		return std::get<0>(base);
+	}
+	node_pointer & get_root() noexcept {
+		return std::get<0>(base);
+	}
+	template<typename U>
+	auto clone(U && other) const {
+		return get_cloner()(std::forward<U>(other));
+	}
+	base_type base;
+	size_type count = 0;
+	size_type shift = 0;
+};
+
+}	// namespace smart_pointer
@@ -0,0 +1,84 @@
+// Copyright David Stone 2015.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Keeps a history of versions of a collection, modifying one element between
+// snapshots, as an undo history would. Compares copying a
+// std::vector<value_ptr<T>> for every snapshot against persistent_vector.
+
+#include "value_ptr.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+using namespace smart_pointer;
+namespace {
+
+constexpr std::size_t snapshot_count = 100;
+
+class Object {
+public:
+	std::array<int, 16> data{};
+};
+
+template<typename Function>
+double time_in_ms(Function && function) {
+	auto const start = std::chrono::steady_clock::now();
+	function();
+	auto const end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void benchmark_vector(std::size_t const size) {
+	std::vector<value_ptr<Object>> current;
+	for (std::size_t n = 0; n != size; ++n) {
+		current.push_back(make_value<Object>());
+	}
+	std::vector<std::vector<value_ptr<Object>>> history;
+	auto const snapshot = time_in_ms([&]() {
+		for (std::size_t n = 0; n != snapshot_count; ++n) {
+			history.push_back(current);
+			++current[n * 7919 % size]->data[0];
+		}
+	});
+	long sum = 0;
+	auto const lookup = time_in_ms([&]() {
+		for (std::size_t n = 0; n != size; ++n) {
+			sum += current[n]->data[0];
+		}
+	});
+	std::cout << "std::vector<value_ptr>, " << size << " elements: snapshot + modify " << snapshot / snapshot_count << " ms, full read " << lookup << " ms (" << sum << ")\n";
+}
+
+void benchmark_persistent(std::size_t const size) {
+	persistent_vector<Object> current;
+	for (std::size_t n = 0; n != size; ++n) {
+		current.push_back(make_value<Object>());
+	}
+	std::vector<persistent_vector<Object>> history;
+	auto const snapshot = time_in_ms([&]() {
+		for (std::size_t n = 0; n != snapshot_count; ++n) {
+			history.push_back(current);
+			current.update(n * 7919 % size, [](Object & object) { ++object.data[0]; });
+		}
+	});
+	long sum = 0;
+	auto const lookup = time_in_ms([&]() {
+		for (std::size_t n = 0; n != size; ++n) {
+			sum += current[n].data[0];
+		}
+	});
+	std::cout << "persistent_vector, " << size << " elements: snapshot + modify " << snapshot / snapshot_count << " ms, full read " << lookup << " ms (" << sum << ")\n";
+}
+
+}	// namespace
+
+int main() {
+	for (std::size_t const size : { 1000, 10000, 100000 }) {
+		benchmark_vector(size);
+		benchmark_persistent(size);
+	}
+}
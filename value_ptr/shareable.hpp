@@ -0,0 +1,165 @@
+// Copyright David Stone 2015.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// shareable_new and shareable_delete allocate the object behind a block of
+// memory that is reserved for the control block of a std::shared_ptr. Moving a
+// value_ptr that uses them into a std::shared_ptr places the control block in
+// that space, so publishing an object that was built as a value_ptr does not
+// allocate, and the reference count is next to the object.
+//
+// The value_ptr itself is still the size of a pointer: the cloner and deleter
+// are stateless, and the reserved space is found from the address of the
+// object. This costs detail::shareable_header_size bytes per object, whether or
+// not it is ever shared. Every pointer owned by such a value_ptr must come from
+// shareable_new<T> or make_shareable_value<T>, and must point to the complete
+// object.
+
+#pragma once
+
+#include "class.hpp"
+#include "requires.hpp"
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace smart_pointer {
+namespace detail {
+
+// The control block of a std::shared_ptr with a stateless deleter and a
+// one-pointer allocator holds a virtual table pointer, two reference counts,
+// the owned pointer, and the allocator. The counts are int in libstdc++ and
+// long in libc++ and the MSVC standard library, whatever the size of a
+// pointer. shareable_allocator fails to compile if this is not enough.
+constexpr std::size_t shared_control_block_reserve = 3 * sizeof(void *) + 2 * sizeof(long);
+
+constexpr std::size_t round_up(std::size_t const size, std::size_t const alignment) {
+	return (size + alignment - 1) / alignment * alignment;
+}
+constexpr std::size_t shareable_header_size = round_up(shared_control_block_reserve, alignof(std::max_align_t));
+
+inline void * shareable_block(void const * object) noexcept {
+	return const_cast<unsigned char *>(static_cast<unsigned char const *>(object)) - shareable_header_size;
+}
+
+template<typename T, typename ... Args>
+T * shareable_construct(Args && ... args) {
+	static_assert(alignof(T) <= alignof(std::max_align_t), "shareable_new does not support over-aligned types.");
+	void * const block = ::operator new(shareable_header_size + sizeof(T));
+	try {
+		return ::new(static_cast<unsigned char *>(block) + shareable_header_size) T(std::forward<Args>(args)...);
+	} catch (...) {
+		::operator delete(block);
+		throw;
+	}
+}
+
+// Hands out the reserved space exactly once, to the control block of the
+// std::shared_ptr. The control block is the last thing to be released, so it
+// frees the whole allocation.
+template<typename T>
+class shareable_allocator {
+public:
+	using value_type = T;
+
+	explicit shareable_allocator(void * block_) noexcept:
+		block(block_) {
+	}
+	template<typename U>
+	shareable_allocator(shareable_allocator<U> const & other) noexcept:
+		block(other.block) {
+	}
+
+	T * allocate(std::size_t const n) {
+		static_assert(sizeof(T) <= shared_control_block_reserve, "The control block of std::shared_ptr does not fit in the reserved space.");
+		static_assert(alignof(T) <= alignof(std::max_align_t), "The control block of std::shared_ptr is over-aligned.");
+		if (n != 1) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(block);
+	}
+	void deallocate(T *, std::size_t) noexcept {
+		::operator delete(block);
+	}
+
+	template<typename U>
+	friend bool operator==(shareable_allocator const & lhs, shareable_allocator<U> const & rhs) noexcept {
+		return lhs.block == rhs.block;
+	}
+	template<typename U>
+	friend bool operator!=(shareable_allocator const & lhs, shareable_allocator<U> const & rhs) noexcept {
+		return lhs.block != rhs.block;
+	}
+private:
+	void * block;
+
+	template<typename U>
+	friend class shareable_allocator;
+};
+
+// The memory belongs to the control block, so the std::shared_ptr only
+// destroys the object.
+template<typename T>
+class shareable_destroy {
+public:
+	void operator()(T * ptr) const noexcept {
+		ptr->~T();
+	}
+};
+
+}	// namespace detail
+
+template<typename T>
+class shareable_new {
+public:
+	constexpr shareable_new() noexcept {}
+	template<typename U>
+	T * operator()(U && other) const {
+		static_assert(
+			!std::is_polymorphic<T>::value and !std::is_polymorphic<U>::value,
+			"shareable_new cannot clone polymorphic types."
+		);
+		return detail::shareable_construct<T>(std::forward<U>(other));
+	}
+};
+
+template<typename T>
+class shareable_delete {
+public:
+	constexpr shareable_delete() noexcept {}
+	void operator()(T * ptr) const noexcept {
+		ptr->~T();
+		::operator delete(detail::shareable_block(ptr));
+	}
+};
+
+template<typename T>
+using shareable_value_ptr = value_ptr<T, shareable_new<T>, shareable_delete<T>>;
+
+template<typename T, typename ... Args>
+shareable_value_ptr<T> make_shareable_value(Args && ... args) {
+	static_assert(!std::is_array<T>::value, "make_shareable_value cannot be used with array types.");
+	return shareable_value_ptr<T>(detail::shareable_construct<T>(std::forward<Args>(args)...));
+}
+
+namespace detail {
+
+template<typename T>
+class shared_ptr_conversion<T, shareable_delete<T>> {
+public:
+	static std::shared_ptr<T> convert(std::unique_ptr<T, shareable_delete<T>> && ptr) {
+		if (!ptr) {
+			return std::shared_ptr<T>();
+		}
+		// Cannot throw: the allocator never allocates.
+		auto const block = shareable_block(ptr.get());
+		return std::shared_ptr<T>(ptr.release(), shareable_destroy<T>{}, shareable_allocator<T>(block));
+	}
+};
+
+}	// namespace detail
+}	// namespace smart_pointer
@@ -0,0 +1,86 @@
+// Copyright David Stone 2015.
+// Distributed under the Boost Software License, Version 1.0.
+// (See accompanying file LICENSE_1_0.txt or copy at
+// http://www.boost.org/LICENSE_1_0.txt)
+
+// Builds objects as value_ptr, mutates them, and publishes them as
+// std::shared_ptr<T const>. Compares make_value followed by the std::shared_ptr
+// constructor against make_shareable_value followed by share().
+
+#include "value_ptr.hpp"
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace {
+
+std::size_t allocations = 0;
+
+}	// namespace
+
+void * operator new(std::size_t const size) {
+	++allocations;
+	if (void * const ptr = std::malloc(size != 0 ? size : 1)) {
+		return ptr;
+	}
+	throw std::bad_alloc();
+}
+void operator delete(void * ptr) noexcept {
+	std::free(ptr);
+}
+void operator delete(void * ptr, std::size_t) noexcept {
+	std::free(ptr);
+}
+
+using namespace smart_pointer;
+namespace {
+
+constexpr std::size_t object_count = 1000000;
+constexpr std::size_t rounds = 5;
+
+class Object {
+public:
+	std::array<int, 16> data{};
+};
+
+template<typename Make, typename Publish>
+void benchmark(char const * name, Make make, Publish publish) {
+	std::vector<std::shared_ptr<Object const>> published;
+	published.reserve(object_count);
+	double total_ms = 0.0;
+	std::size_t total_allocations = 0;
+	for (std::size_t round = 0; round != rounds; ++round) {
+		published.clear();
+		auto const allocations_before = allocations;
+		auto const start = std::chrono::steady_clock::now();
+		for (std::size_t n = 0; n != object_count; ++n) {
+			auto ptr = make();
+			ptr->data[0] = static_cast<int>(n);
+			published.emplace_back(publish(std::move(ptr)));
+		}
+		auto const end = std::chrono::steady_clock::now();
+		total_ms += std::chrono::duration<double, std::milli>(end - start).count();
+		total_allocations += allocations - allocations_before;
+	}
+	std::cout << name << ": " << total_ms / rounds << " ms, " << static_cast<double>(total_allocations) / (rounds * object_count) << " allocations per object\n";
+}
+
+}	// namespace
+
+int main() {
+	benchmark(
+		"make_value + shared_ptr",
+		[]() { return make_value<Object>(); },
+		[](value_ptr<Object> && ptr) { return std::shared_ptr<Object const>(std::move(ptr)); }
+	);
+	benchmark(
+		"make_shareable_value + share",
+		[]() { return make_shareable_value<Object>(); },
+		[](shareable_value_ptr<Object> && ptr) { return std::move(ptr).share(); }
+	);
+}
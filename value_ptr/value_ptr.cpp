@@ -6,8 +6,12 @@
 #include "value_ptr.hpp"
 #include <algorithm>
 #include <cassert>
+#include <functional>
 #include <iostream>
+#include <numeric>
+#include <string>
 #include <tuple>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
@@ -47,6 +51,7 @@ std::size_t Tester::destructed = 0;
 
 static_assert(sizeof(value_ptr<Tester>) == sizeof(Tester *), "value_ptr wrong size!");
 static_assert(sizeof(value_ptr<Tester[]>) == sizeof(Tester *), "value_ptr array wrong size!");
+static_assert(sizeof(shareable_value_ptr<Tester>) == sizeof(Tester *), "shareable_value_ptr wrong size!");
 
 #define CHECK_EQUALS(condition1, condition2) do { \
 	if ((condition1) != (condition2)) { \
@@ -211,13 +216,287 @@ void test_virtual_cloning() {
 //	static_cast<void>(other);
 }
 
+void test_value_hashing() {
+	auto const a = make_value<std::string>("value");
+	auto const b = make_value<std::string>("value");
+	auto const c = make_value<std::string>("other");
+	value_ptr<std::string> const null;
+	CHECK_EQUALS(std::hash<value_ptr<std::string>>()(a), std::hash<std::string *>()(a.get()));
+	CHECK_EQUALS(value_hash<std::string>()(a), value_hash<std::string>()(b));
+	CHECK_EQUALS(value_hash<std::string>()(null), 0);
+	CHECK_EQUALS(value_equal<std::string>()(a, b), true);
+	CHECK_EQUALS(value_equal<std::string>()(a, c), false);
+	CHECK_EQUALS(value_equal<std::string>()(a, null), false);
+	CHECK_EQUALS(value_equal<std::string>()(null, null), true);
+
+	std::unordered_set<value_ptr<std::string>, value_hash<std::string>, value_equal<std::string>> set;
+	set.insert(a);
+	CHECK_EQUALS(set.count(b), 1);
+	CHECK_EQUALS(set.count(c), 0);
+}
+
+class seeded_hash {
+public:
+	seeded_hash() = default;
+	explicit seeded_hash(std::size_t const seed_):
+		seed(seed_) {
+	}
+	std::size_t operator()(std::string const & value) const {
+		return std::hash<std::string>()(value) ^ seed;
+	}
+private:
+	std::size_t seed = 0x5eed;
+};
+
+void test_hashed_value_ptr_hash_functions() {
+	using seeded_ptr = hashed_value_ptr<std::string, default_new<std::string>, std::default_delete<std::string>, seeded_hash>;
+	hashed_value_ptr<std::string> a(std::string("x"));
+	seeded_ptr b(std::string("x"));
+	CHECK_EQUALS(a.hash() != b.hash(), true);
+	CHECK_EQUALS(a == b, true);
+
+	seeded_ptr c(make_value<std::string>("x"), seeded_hash(1));
+	seeded_ptr d(make_value<std::string>("x"), seeded_hash(2));
+	CHECK_EQUALS(c.hash() != d.hash(), true);
+	CHECK_EQUALS(c == d, true);
+}
+
+void test_hashed_value_ptr() {
+	static_assert(std::is_same<decltype(*std::declval<hashed_value_ptr<int> const &>()), int const &>::value, "hashed_value_ptr must not allow mutation through operator*.");
+	static_assert(noexcept(std::hash<hashed_value_ptr<std::string>>()(std::declval<hashed_value_ptr<std::string> const &>())), "Hashing must be noexcept so unordered containers use the stored hash.");
+	hashed_value_ptr<std::string> a(std::string("value"));
+	CHECK_EQUALS(a.hash(), std::hash<std::string>()("value"));
+
+	auto b = a;
+	CHECK_EQUALS(b.hash(), a.hash());
+	CHECK_EQUALS(a == b, true);
+	CHECK_EQUALS(a.get() != b.get(), true);
+
+	b.mutate([](std::string & value) { value = "other"; });
+	CHECK_EQUALS(b.hash(), std::hash<std::string>()("other"));
+	CHECK_EQUALS(a != b, true);
+
+	try {
+		b.mutate([](std::string & value) {
+			value = "thrown";
+			throw 0;
+		});
+	} catch (int) {
+	}
+	CHECK_EQUALS(b.hash(), std::hash<std::string>()("thrown"));
+	b.mutate([](std::string & value) { value = "other"; });
+
+	auto moved_to = std::move(b);
+	CHECK_EQUALS(moved_to.hash(), std::hash<std::string>()("other"));
+	CHECK_EQUALS(b == nullptr, true);
+	CHECK_EQUALS(b.hash(), 0);
+	CHECK_EQUALS(b == hashed_value_ptr<std::string>(), true);
+	CHECK_EQUALS(a == b, false);
+
+	std::unordered_set<hashed_value_ptr<std::string>> set;
+	set.insert(a);
+	set.insert(moved_to);
+	set.insert(hashed_value_ptr<std::string>(std::string("value")));
+	CHECK_EQUALS(set.size(), 2);
+	CHECK_EQUALS(set.count(hashed_value_ptr<std::string>(std::string("other"))), 1);
+	set.rehash(set.bucket_count() * 4);
+	CHECK_EQUALS(set.count(a), 1);
+
+	a.reset(new std::string("reset"));
+	CHECK_EQUALS(a.hash(), std::hash<std::string>()("reset"));
+	delete a.release();
+	CHECK_EQUALS(a.hash(), 0);
+}
+
+void test_shareable(Verify<Tester> & verify) {
+	verify();
+	{
+		auto p = make_shareable_value<Tester>();
+		verify.default_construct();
+		auto copy = p;
+		verify.copy_construct();
+		verify();
+		auto const address = p.get();
+		std::shared_ptr<Tester> shared = std::move(p).share();
+		CHECK_EQUALS(p == nullptr, true);
+		CHECK_EQUALS(shared.get(), address);
+		CHECK_EQUALS(shared.use_count(), 1);
+		std::weak_ptr<Tester> weak = shared;
+		shared.reset();
+		verify.destruct();
+		verify();
+		CHECK_EQUALS(weak.expired(), true);
+
+		std::shared_ptr<Tester const> published = std::move(copy);
+		CHECK_EQUALS(copy == nullptr, true);
+		CHECK_EQUALS(published != nullptr, true);
+		verify();
+	}
+	verify.destruct();
+	verify();
+
+	std::shared_ptr<Tester> null = shareable_value_ptr<Tester>().share();
+	CHECK_EQUALS(null == nullptr, true);
+
+	std::shared_ptr<int> from_value_ptr = make_value<int>(5);
+	CHECK_EQUALS(*from_value_ptr, 5);
+}
+
+void test_persistent_vector_sharing(Verify<Tester> & verify) {
+	verify();
+	{
+		// Enough elements for three levels of the tree.
+		constexpr std::size_t size = 2000;
+		persistent_vector<Tester> v;
+		for (std::size_t n = 0; n != size; ++n) {
+			v.push_back(make_value<Tester>());
+			verify.default_construct();
+		}
+		verify();
+		auto snapshot = v;
+		verify();
+		v.update(1500, [](Tester &) {});
+		verify.copy_construct();
+		verify();
+		CHECK_EQUALS(v.get(1500) != snapshot.get(1500), true);
+		CHECK_EQUALS(v.get(1499), snapshot.get(1499));
+		v.update(1500, [](Tester &) {});
+		verify();
+		auto copy = v.copy(0);
+		verify.copy_construct();
+		verify();
+		while (!v.empty()) {
+			v.pop_back();
+		}
+		verify.destruct();	// The clone of element 1500
+		verify();
+		CHECK_EQUALS(snapshot.size(), size);
+		verify.destruct();	// copy
+		for (std::size_t n = 0; n != size; ++n) {
+			verify.destruct();
+		}
+	}
+	verify();
+}
+
+class counting_cloner {
+public:
+	counting_cloner() = default;
+	explicit counting_cloner(std::size_t & count_):
+		count(&count_) {
+	}
+	int * operator()(int const & value) const {
+		if (count != nullptr) {
+			++*count;
+		}
+		return new int(value);
+	}
+private:
+	std::size_t * count = nullptr;
+};
+
+class counting_deleter {
+public:
+	counting_deleter() = default;
+	explicit counting_deleter(std::size_t & count_):
+		count(&count_) {
+	}
+	void operator()(int * ptr) const {
+		if (count != nullptr) {
+			++*count;
+		}
+		delete ptr;
+	}
+private:
+	std::size_t * count = nullptr;
+};
+
+void test_persistent_vector_policies() {
+	using element = value_ptr<int, counting_cloner, counting_deleter>;
+	std::size_t vector_clones = 0;
+	std::size_t element_clones = 0;
+	std::size_t deletes = 0;
+	{
+		persistent_vector<int, counting_cloner, counting_deleter> v{counting_cloner(vector_clones)};
+		v.push_back(5);
+		CHECK_EQUALS(vector_clones, 1);
+		v.push_back(element(new int(6), counting_cloner(element_clones), counting_deleter(deletes)));
+		auto const snapshot = v;
+		v.update(1, [](int & value) { ++value; });
+		CHECK_EQUALS(element_clones, 1);
+		CHECK_EQUALS(vector_clones, 1);
+		CHECK_EQUALS(v[1], 7);
+		CHECK_EQUALS(snapshot[1], 6);
+
+		auto copy = v.copy(1);
+		CHECK_EQUALS(element_clones, 2);
+		auto copy_of_copy = copy;
+		CHECK_EQUALS(element_clones, 3);
+		copy.reset();
+		copy_of_copy.reset();
+		CHECK_EQUALS(deletes, 2);
+	}
+	// The original element and its clone in the vector
+	CHECK_EQUALS(deletes, 4);
+}
+
+void test_persistent_vector_values() {
+	constexpr int size = 5000;
+	persistent_vector<int> v;
+	std::vector<persistent_vector<int>> history;
+	for (int n = 0; n != size; ++n) {
+		v.push_back(n);
+		history.push_back(v);
+	}
+	v.set(100, 7);
+	v.update(4000, [](int & value) { value = -1; });
+	v.set(4001, make_value<int>(3));
+	v.set(4002, nullptr);
+	CHECK_EQUALS(v[100], 7);
+	CHECK_EQUALS(v[4000], -1);
+	CHECK_EQUALS(v[4001], 3);
+	CHECK_EQUALS(v.get(4002) == nullptr, true);
+	CHECK_EQUALS(*v.copy(4001), 3);
+	CHECK_EQUALS(v.copy(4002) == nullptr, true);
+	while (v.size() != 10) {
+		v.pop_back();
+	}
+	for (int n = 0; n != 40; ++n) {
+		v.push_back(n);
+	}
+	CHECK_EQUALS(v.size(), 50);
+	CHECK_EQUALS(v[49], 39);
+	for (std::size_t version = 0; version != history.size(); ++version) {
+		CHECK_EQUALS(history[version].size(), version + 1);
+		CHECK_EQUALS(history[version][version], static_cast<int>(version));
+	}
+	auto const & last = history.back();
+	for (int n = 0; n != size; ++n) {
+		CHECK_EQUALS(last[static_cast<std::size_t>(n)], n);
+	}
+
+	persistent_vector<int, shareable_new<int>, shareable_delete<int>> shareable;
+	shareable.push_back(make_shareable_value<int>(1));
+	auto shareable_snapshot = shareable;
+	shareable.update(0, [](int & value) { ++value; });
+	CHECK_EQUALS(shareable[0], 2);
+	CHECK_EQUALS(shareable_snapshot[0], 1);
+}
+
 }	// namespace
 
 int main() {
 	Verify<Tester> verify;
 	test_constructors(verify);
 	verify();
+	test_shareable(verify);
+	test_persistent_vector_sharing(verify);
 	test_assignment(verify);
 	test_semantics();
 	test_virtual_cloning();
+	test_value_hashing();
+	test_hashed_value_ptr();
+	test_hashed_value_ptr_hash_functions();
+	test_persistent_vector_values();
+	test_persistent_vector_policies();
 }
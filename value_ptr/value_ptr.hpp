@@ -7,4 +7,8 @@
 
 #include "class.hpp"
 #include "comparison_operators.hpp"
+#include "hash.hpp"
+#include "hashed_value_ptr.hpp"
 #include "make_value.hpp"
+#include "persistent_vector.hpp"
+#include "shareable.hpp"